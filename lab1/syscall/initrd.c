@@ -1,8 +1,73 @@
+#define _GNU_SOURCE
 #define SYS_HELLO 548
+#define SYS_INVALID 1000 // 不存在的系统调用号，内核直接返回 -ENOSYS
+#define DEFAULT_ITERS 100000
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/reboot.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
+// 内核命令行中不认识的 key=value 参数会作为环境变量传给 init，
+// 例如 `-append "bench_iters=1000000"` 设置每项测试的调用次数
+
+static char hello_buf[17];
+
+static long call_hello(void) {
+    return syscall(SYS_HELLO, hello_buf, sizeof(hello_buf) - 1);
+}
+
+static long call_getpid(void) {
+    return syscall(SYS_getpid);
+}
+
+static long call_invalid(void) {
+    return syscall(SYS_INVALID);
+}
+
+// 只测量计时本身的开销；noinline 和空的 asm 防止编译器把这次调用优化掉
+__attribute__((noinline)) static long call_nothing(void) {
+    __asm__ volatile("");
+    return 0;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
+
+// 每次调用单独计时，减去 overhead（计时本身开销的中位数）后得到平均值和分布，
+// 平均值和各分位数来自同一组样本。返回减去之前的中位数
+static long long bench(const char *name, long (*fn)(void), long n, long long *samples, long long overhead) {
+    for (long i = 0; i < n / 10; ++i) // 预热
+        fn();
+
+    for (long i = 0; i < n; ++i) {
+        long long start = now_ns();
+        fn();
+        samples[i] = now_ns() - start;
+    }
+    qsort(samples, n, sizeof(long long), cmp_ll);
+    long long median = samples[n / 2];
+
+    double sum = 0;
+    for (long i = 0; i < n; ++i) {
+        samples[i] = samples[i] > overhead ? samples[i] - overhead : 0; // 减去后仍然有序
+        sum += samples[i];
+    }
+
+    printf("%-10s mean %8.1f ns/call  min %6lld  median %6lld  p99 %6lld\n",
+        name, sum / n, samples[0], samples[n / 2], samples[n * 99 / 100]);
+    return median;
+}
+
 int main(int argc, char *argv[]) {
     long res1, res2;
     char buf1[5]; // length not enough
@@ -14,5 +79,31 @@ int main(int argc, char *argv[]) {
     printf("Test1: buffer size too small, return value: %ld\n", res1);
     res2 = syscall(SYS_HELLO, buf2, len2);
     printf("Test2: buffer size is enough, return value: %ld, contents in buf2: %s", res2, buf2);
-    while (1) {}
+
+    long n = DEFAULT_ITERS;
+    const char *iters = getenv("bench_iters");
+    if (iters && atol(iters) > 0)
+        n = atol(iters);
+    long long *samples = malloc(n * sizeof(long long));
+    if (samples == NULL) {
+        printf("Failed to allocate %ld samples\n", n);
+    } else {
+        // timer 一行是计时本身的开销，其余各行都已减去它的中位数
+        printf("\nBenchmark: %ld calls each\n", n);
+        long long overhead = bench("timer", call_nothing, n, samples, 0);
+        bench("getpid", call_getpid, n, samples, overhead);
+        bench("invalid", call_invalid, n, samples, overhead);
+        bench("hello", call_hello, n, samples, overhead);
+        free(samples);
+    }
+    fflush(stdout);
+
+    // 作为 init 运行时关机，而不是忙等占满虚拟机的 CPU
+    if (getpid() == 1) {
+        sync();
+        reboot(RB_POWER_OFF);
+        while (1) // 关机失败时也不能退出，否则内核会 panic
+            pause();
+    }
+    return 0;
 }
@@ -0,0 +1,257 @@
+#include "bench.h"
+
+struct bench_result {
+    std::string cmd;
+    std::vector<double> wall; // 每次运行的墙钟时间（ms），已排序
+    double mean, stddev, user, sys;
+    int outliers;
+    int failures = 0;         // 退出码非 0 的次数（-i 时）
+    bool failed = false;      // 没有 -i 时遇到失败就停止
+};
+
+static volatile sig_atomic_t bench_interrupted = 0;
+
+static void bench_sigint(int) {
+    bench_interrupted = 1;
+}
+
+static void bench_usage() {
+    std::cout << "Usage: bench [-n N] [-w WARMUP] [-i] [--] pipeline [::: pipeline2]\n";
+}
+
+bool is_bench(const std::string &cmd) {
+    std::istringstream in(cmd);
+    std::string word;
+    in >> word;
+    return word == "bench";
+}
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double timeval_ms(const struct timeval &tv) {
+    return tv.tv_sec * 1e3 + tv.tv_usec / 1e3;
+}
+
+// 排好序的样本的 p 分位数，相邻样本间线性插值
+static double percentile(const std::vector<double> &sorted, double p) {
+    double pos = p * (sorted.size() - 1);
+    size_t lo = (size_t) pos;
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+// 运行 warmup + n 次，只统计后 n 次。调用前标准输出已指向 /dev/null。
+// 按 Ctrl + C 或（没有 -i 时）命令失败会提前停止，只统计已完成的运行
+static bench_result run_bench(const std::string &cmd, int n, int warmup, bool ignore_failure,
+                              std::vector<std::string> &all_history) {
+    bench_result res;
+    res.cmd = cmd;
+    struct timeval user = {0, 0}, sys = {0, 0};
+
+    for (int i = 0; i < warmup + n && !bench_interrupted; ++i) {
+        std::string pipeline = cmd; // exec_pipe 可能修改传入的命令
+        struct rusage before = child_usage;
+        double start = now_ms();
+        exec_pipe(pipeline, all_history);
+        double elapsed = now_ms() - start;
+        std::cout.flush();
+        if (bench_interrupted) {
+            break; // 被中断的这次不计入
+        }
+        // 和 shell 一样只看最后一个阶段，`yes | head -n 1` 中 yes 被 SIGPIPE 杀死不算失败
+        if (last_status != 0) {
+            if (!ignore_failure) {
+                res.failed = true;
+                break;
+            }
+        }
+        if (i < warmup) {
+            continue;
+        }
+        if (last_status != 0) {
+            res.failures++;
+        }
+
+        res.wall.push_back(elapsed);
+        struct timeval delta;
+        timersub(&child_usage.ru_utime, &before.ru_utime, &delta);
+        timeradd(&user, &delta, &user);
+        timersub(&child_usage.ru_stime, &before.ru_stime, &delta);
+        timeradd(&sys, &delta, &sys);
+    }
+
+    int runs = res.wall.size();
+    if (runs == 0) {
+        return res;
+    }
+    std::sort(res.wall.begin(), res.wall.end());
+    double sum = 0;
+    for (double t : res.wall) {
+        sum += t;
+    }
+    res.mean = sum / runs;
+    double var = 0;
+    for (double t : res.wall) {
+        var += (t - res.mean) * (t - res.mean);
+    }
+    res.stddev = runs > 1 ? std::sqrt(var / (runs - 1)) : 0;
+    res.user = timeval_ms(user) / runs;
+    res.sys = timeval_ms(sys) / runs;
+
+    // 四分位距 1.5 倍以外的样本视为离群值
+    double q1 = percentile(res.wall, 0.25), q3 = percentile(res.wall, 0.75);
+    double iqr = q3 - q1;
+    res.outliers = 0;
+    for (double t : res.wall) {
+        if (t < q1 - 1.5 * iqr || t > q3 + 1.5 * iqr) {
+            res.outliers++;
+        }
+    }
+    return res;
+}
+
+static void print_result(int index, const bench_result &res) {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Benchmark " << index << ": " << res.cmd << "\n";
+    if (res.wall.empty()) {
+        std::cout << "  No completed runs\n";
+        return;
+    }
+    std::cout << "  Time (mean +- sd):  " << res.mean << " ms +- " << res.stddev << " ms"
+              << "    [User: " << res.user << " ms, System: " << res.sys << " ms]\n";
+    std::cout << "  Range (min / median / p95 / max):  " << res.wall.front() << " / "
+              << percentile(res.wall, 0.5) << " / " << percentile(res.wall, 0.95) << " / "
+              << res.wall.back() << " ms    " << res.wall.size() << " runs\n";
+    if (res.outliers > 0) {
+        std::cout << "  Warning: " << res.outliers << " statistical outlier(s) detected\n";
+    }
+    if (res.failures > 0) {
+        std::cout << "  Warning: " << res.failures << " run(s) exited with a non-zero status\n";
+    }
+}
+
+// 按单独成词的 ::: 把两条管道分开，管道内部的 -- 等参数不受影响
+static std::vector<std::string> split_pipelines(const std::string &rest) {
+    std::vector<std::string> cmds;
+    size_t begin = 0, pos = 0;
+    while ((pos = rest.find(":::", pos)) != std::string::npos) {
+        bool word_start = pos == 0 || std::isspace((unsigned char) rest[pos - 1]);
+        bool word_end = pos + 3 == rest.size() || std::isspace((unsigned char) rest[pos + 3]);
+        if (word_start && word_end) {
+            cmds.push_back(rest.substr(begin, pos - begin));
+            begin = pos + 3;
+        }
+        pos += 3;
+    }
+    cmds.push_back(rest.substr(begin));
+    return cmds;
+}
+
+void exec_bench(const std::string &cmd, std::vector<std::string> &all_history) {
+    std::istringstream in(cmd);
+    std::string word;
+    in >> word; // bench
+
+    int n = 10, warmup = 1;
+    bool ignore_failure = false;
+    std::string rest;
+    while (in >> word) {
+        // 读到最后一个词时 tellg 返回 -1
+        size_t end = in.tellg() == -1 ? cmd.size() : (size_t) in.tellg();
+        if (word == "--") {
+            rest = cmd.substr(end);
+            break;
+        }
+        if (word == "-i") {
+            ignore_failure = true;
+            continue;
+        }
+        if (word != "-n" && word != "-w") {
+            rest = cmd.substr(end - word.size()); // 第一个不是选项的词是管道的开始
+            break;
+        }
+
+        std::string value;
+        int count = 0;
+        in >> value;
+        std::stringstream count_stream(value);
+        count_stream >> count;
+        if (!count_stream.eof() || count_stream.fail() || count < 0 || (word == "-n" && count == 0)) {
+            std::cout << "bench: invalid count '" << value << "'\n";
+            return;
+        }
+        (word == "-n" ? n : warmup) = count;
+    }
+
+    std::vector<std::string> cmds = split_pipelines(rest);
+    if (cmds.size() > 2) {
+        bench_usage();
+        return;
+    }
+    for (auto &c : cmds) {
+        trim(c);
+        if (c.empty()) {
+            bench_usage();
+            return;
+        }
+    }
+
+    // 只打开一次 /dev/null，所有运行期间标准输出都指向它
+    int null_fd = open("/dev/null", O_WRONLY);
+    int saved_stdout = dup(STDOUT_FILENO);
+    if (null_fd < 0 || saved_stdout < 0) {
+        std::cout << "bench: cannot redirect stdout\n";
+        return;
+    }
+    std::cout.flush();
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    // 运行期间 Ctrl + C 用来停止测试，结束后恢复原来的处理函数
+    bench_interrupted = 0;
+    struct sigaction sa, old_sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = bench_sigint;
+    sa.sa_flags = SA_RESTART; // 不打断正在等待的子进程，每次运行之间再检查 bench_interrupted
+    sigaction(SIGINT, &sa, &old_sa);
+
+    std::vector<bench_result> results;
+    for (const auto &c : cmds) {
+        results.push_back(run_bench(c, n, warmup, ignore_failure, all_history));
+        if (bench_interrupted || results.back().failed) {
+            break;
+        }
+    }
+
+    sigaction(SIGINT, &old_sa, nullptr);
+    std::cout.flush();
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    if (bench_interrupted) {
+        std::cout << "\nbench: interrupted, showing completed runs only\n";
+    }
+    // 某条命令失败时，仍然先给出已完成的结果，再报错
+    bool failed = results.back().failed;
+    for (size_t i = 0; i < results.size(); ++i) {
+        print_result(i + 1, results[i]);
+    }
+    if (failed) {
+        std::cout << "bench: '" << results.back().cmd
+                  << "' exited with a non-zero status; use -i to ignore failures\n";
+    } else if (results.size() == 2 && !results[0].wall.empty() && !results[1].wall.empty()) {
+        const bench_result &a = results[0], &b = results[1];
+        bool a_faster = a.mean <= b.mean;
+        const bench_result &fast = a_faster ? a : b, &slow = a_faster ? b : a;
+        double ratio = slow.mean / fast.mean;
+        double ratio_sd = ratio * std::sqrt(std::pow(slow.stddev / slow.mean, 2) + std::pow(fast.stddev / fast.mean, 2));
+        std::cout << "Summary\n  '" << fast.cmd << "' ran " << ratio << " +- " << ratio_sd
+                  << " times faster than '" << slow.cmd << "'\n";
+    }
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout << std::setprecision(6);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "utils.h"
+// clock_gettime
+#include <ctime>
+// sqrt
+#include <cmath>
+// sigaction
+#include <csignal>
+
+// 重复计时一条管道
+//
+// bench [-n N] [-w WARMUP] [-i] [--] pipeline [::: pipeline2]
+//   先运行 WARMUP 次预热，再运行 N 次并统计墙钟时间和 CPU 时间，
+//   用单独成词的 ::: 给出第二条管道时并排比较两者。管道的标准输出被丢弃到 /dev/null。
+//   命令退出码非 0 时停止，-i 则忽略失败继续计时；Ctrl + C 停止并输出已完成的运行
+
+void exec_pipe(std::string &, std::vector<std::string> &);
+
+bool is_bench(const std::string &cmd);
+void exec_bench(const std::string &cmd, std::vector<std::string> &all_history);
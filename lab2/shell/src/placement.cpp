@@ -0,0 +1,342 @@
+#include "placement.h"
+// mkdir
+#include <sys/stat.h>
+
+int current_stage = 0;
+
+struct placement {
+    bool auto_pin = false;                     // -a
+    std::vector<std::string> stage_lists;      // -c 给出的各阶段 CPU 列表
+    std::vector<std::string> stage_overrides;  // 阶段前的 @CPUS
+    std::vector<cpu_set_t> stage_cpus;         // 解析后每个阶段的 CPU 集合，空集表示不绑定
+    std::string cgroup_parent;                 // -g
+    std::string cpu_max;                       // -C 换算出的 cpu.max
+    std::string mem_max;                       // -m
+    std::string job_cgroup;                    // 本次作业的 cgroup 路径
+    std::vector<std::string> created;          // 本次作业新建的 cgroup，结束时逆序删除
+};
+
+static placement job;
+
+static void pin_usage() {
+    std::cout << "Usage: pin [-a] [-c CPUS[:CPUS...]] [-g CGROUP] [-C PERCENT] [-m MEMORY] [--] pipeline\n";
+}
+
+static bool write_file(const std::string &path, const std::string &value) {
+    int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, value.c_str(), value.size()) == (ssize_t) value.size();
+    close(fd);
+    return ok;
+}
+
+// 解析 0-3,8,10-11 这样的 CPU 列表
+bool parse_cpu_list(const std::string &list, cpu_set_t &set) {
+    CPU_ZERO(&set);
+    std::vector<std::string> ranges = split(list, ",");
+    for (const auto &range : ranges) {
+        const char *p = range.c_str();
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end != p && *end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        if (end == p || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0;
+}
+
+// 与 cpu 共享某一级（数据或统一）缓存的 CPU 中编号最小的一个，读不到时返回 cpu 本身
+static int cache_domain(int cpu, int level) {
+    std::string cache_path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+    for (int index = 0;; ++index) {
+        std::string dir = cache_path + std::to_string(index);
+        std::ifstream level_file(dir + "/level");
+        if (!level_file) {
+            break;
+        }
+        int cache_level = 0;
+        std::string type, shared;
+        level_file >> cache_level;
+        std::ifstream(dir + "/type") >> type;
+        std::ifstream(dir + "/shared_cpu_list") >> shared;
+
+        cpu_set_t set;
+        if (cache_level == level && type != "Instruction" && parse_cpu_list(shared, set)) {
+            for (int i = 0; i < CPU_SETSIZE; ++i) {
+                if (CPU_ISSET(i, &set)) {
+                    return i;
+                }
+            }
+        }
+    }
+    return cpu;
+}
+
+// 当前可用的 CPU，按 L3 再按 L2 分组排序，相邻的 CPU 尽量共享缓存
+std::vector<int> cache_ordered_cpus() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        return {};
+    }
+
+    std::vector<std::tuple<int, int, int> > cpus; // (L3 域, L2 域, CPU)
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.emplace_back(cache_domain(cpu, 3), cache_domain(cpu, 2), cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+
+    std::vector<int> order;
+    for (const auto &c : cpus) {
+        order.push_back(std::get<2>(c));
+    }
+    return order;
+}
+
+// 处理 pin 前缀，成功时把 cmd 换成去掉 pin 选项后的管道
+bool parse_pin(std::string &cmd) {
+    std::istringstream in(cmd);
+    std::string word;
+    in >> word;
+    if (word != "pin") {
+        return true;
+    }
+
+    job = placement();
+    std::string rest;
+    while (in >> word) {
+        // 读到最后一个词时 tellg 返回 -1
+        size_t end = in.tellg() == -1 ? cmd.size() : (size_t) in.tellg();
+        if (word == "--") {
+            rest = cmd.substr(end);
+            break;
+        }
+        if (word == "-a") {
+            job.auto_pin = true;
+            continue;
+        }
+        if (word != "-c" && word != "-g" && word != "-C" && word != "-m") {
+            rest = cmd.substr(end - word.size()); // 第一个不是选项的词是管道的开始
+            break;
+        }
+
+        std::string value;
+        if (!(in >> value)) {
+            pin_usage();
+            return false;
+        }
+        if (word == "-c") {
+            job.stage_lists = split(value, ":");
+            for (const auto &list : job.stage_lists) {
+                cpu_set_t set;
+                if (!parse_cpu_list(list, set)) {
+                    std::cout << "pin: invalid cpu list '" << list << "'\n";
+                    return false;
+                }
+            }
+        } else if (word == "-g") {
+            job.cgroup_parent = value;
+        } else if (word == "-C") {
+            std::stringstream percent_stream(value);
+            int percent = 0;
+            percent_stream >> percent;
+            if (!percent_stream.eof() || percent_stream.fail() || percent <= 0) {
+                std::cout << "pin: invalid cpu percent '" << value << "'\n";
+                return false;
+            }
+            // 每 100ms 周期内最多运行 percent ms，超过 100 表示多个核
+            job.cpu_max = std::to_string(percent * 1000) + " 100000";
+        } else {
+            job.mem_max = value;
+        }
+    }
+
+    trim(rest);
+    if (rest.empty()) {
+        pin_usage();
+        return false;
+    }
+    if (job.cgroup_parent.empty() && (!job.cpu_max.empty() || !job.mem_max.empty())) {
+        job.cgroup_parent = "shell";
+    }
+    cmd = rest;
+    return true;
+}
+
+// 处理阶段前的 @CPUS，并把它从命令中去掉；去掉后阶段为空时报错
+bool parse_stage_pins(std::vector<std::string> &pipe_args) {
+    job.stage_overrides.assign(pipe_args.size(), "");
+    for (size_t i = 0; i < pipe_args.size(); ++i) {
+        std::string &stage = pipe_args[i];
+        if (stage[0] != '@') {
+            continue;
+        }
+        size_t pos = stage.find_first_of(" \t");
+        std::string list = stage.substr(1, pos == std::string::npos ? std::string::npos : pos - 1);
+        job.stage_overrides[i] = list;
+        stage = pos == std::string::npos ? "" : stage.substr(pos + 1);
+        trim(stage);
+        if (stage.empty()) {
+            std::cout << "Usage: @CPUS command [| @CPUS command ...]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string cgroup2_root() {
+    std::ifstream mounts("/proc/self/mounts");
+    std::string device, dir, type, rest;
+    while (mounts >> device >> dir >> type && std::getline(mounts, rest)) {
+        if (type == "cgroup2") {
+            return dir;
+        }
+    }
+    return "";
+}
+
+// shell 自己所在的 cgroup，即 /proc/self/cgroup 中 0:: 一行，相对挂载点
+static std::string cgroup2_self() {
+    std::ifstream cgroups("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroups, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            std::string path = line.substr(3);
+            return path == "/" ? "" : path;
+        }
+    }
+    return "";
+}
+
+// 逐级创建 cgroup 并打开所需的控制器，再为本次作业建一个子 cgroup 写入限制。
+// -g 以 / 开头时相对 cgroup v2 的挂载点，否则相对 shell 自己所在的 cgroup
+static bool create_job_cgroup() {
+    static int job_count = 0;
+
+    std::string root = cgroup2_root();
+    if (root.empty()) {
+        std::cout << "pin: cgroup v2 is not mounted\n";
+        return false;
+    }
+
+    std::vector<std::string> controllers;
+    if (!job.cpu_max.empty()) {
+        controllers.push_back("+cpu");
+    }
+    if (!job.mem_max.empty()) {
+        controllers.push_back("+memory");
+    }
+
+    std::string path = root;
+    if (job.cgroup_parent[0] != '/') {
+        path += cgroup2_self();
+    }
+    std::vector<std::string> components = split(job.cgroup_parent, "/");
+    components.push_back("job-" + std::to_string(getpid()) + "-" + std::to_string(++job_count));
+    for (const auto &component : components) {
+        // 有进程的非根 cgroup 不能打开控制器，这里失败时交给下面写限制时报错
+        for (const auto &controller : controllers) {
+            write_file(path + "/cgroup.subtree_control", controller);
+        }
+        path += "/" + component;
+        if (mkdir(path.c_str(), 0755) == 0) {
+            job.created.push_back(path);
+        } else if (errno != EEXIST) {
+            std::cout << "pin: cannot create cgroup " << path << "\n";
+            return false;
+        }
+    }
+    job.job_cgroup = path;
+
+    if ((!job.cpu_max.empty() && !write_file(path + "/cpu.max", job.cpu_max))
+        || (!job.mem_max.empty() && !write_file(path + "/memory.max", job.mem_max))) {
+        std::cout << "pin: cannot set limits on cgroup " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 在 fork 各阶段之前确定每个阶段的 CPU 集合，并准备作业的 cgroup
+bool begin_job(int stage_num) {
+    cpu_set_t none;
+    CPU_ZERO(&none);
+    job.stage_cpus.assign(stage_num, none);
+
+    std::vector<int> order;
+    if (job.auto_pin) {
+        order = cache_ordered_cpus();
+    }
+    // 指定的 CPU 必须都在 shell 当前可用的范围内，在 fork 之前就拒绝
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        std::cout << "pin: sched_getaffinity failed\n";
+        return false;
+    }
+    for (int i = 0; i < stage_num; ++i) {
+        std::string list;
+        if (i < (int) job.stage_overrides.size() && !job.stage_overrides[i].empty()) {
+            list = job.stage_overrides[i];
+        } else if (!job.stage_lists.empty()) {
+            list = job.stage_lists[i % job.stage_lists.size()];
+        }
+
+        if (!list.empty()) {
+            if (!parse_cpu_list(list, job.stage_cpus[i])) {
+                std::cout << "pin: invalid cpu list '" << list << "'\n";
+                return false;
+            }
+            cpu_set_t usable;
+            CPU_AND(&usable, &job.stage_cpus[i], &allowed);
+            if (!CPU_EQUAL(&usable, &job.stage_cpus[i])) {
+                std::cout << "pin: cpu list '" << list << "' is not within the available cpus\n";
+                return false;
+            }
+        } else if (!order.empty()) {
+            CPU_SET(order[i % order.size()], &job.stage_cpus[i]);
+        }
+    }
+
+    if (!job.cgroup_parent.empty()) {
+        return create_job_cgroup();
+    }
+    return true;
+}
+
+// 删除本次作业新建的 cgroup，已存在的或仍被其他作业使用的（rmdir 失败）保留
+void end_job() {
+    for (auto it = job.created.rbegin(); it != job.created.rend(); ++it) {
+        if (rmdir(it->c_str()) < 0) {
+            break;
+        }
+    }
+    job = placement();
+    current_stage = 0;
+}
+
+// 在 exec 之前由子进程调用，affinity 和 cgroup 都会被之后创建的进程继承
+void apply_placement(int stage) {
+    if (stage < (int) job.stage_cpus.size() && CPU_COUNT(&job.stage_cpus[stage]) > 0) {
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &job.stage_cpus[stage]) < 0) {
+            // 此时标准输出可能已经接到管道上，报错要走标准错误
+            std::cerr << "pin: sched_setaffinity failed\n";
+        }
+    }
+    if (!job.job_cgroup.empty()) {
+        if (!write_file(job.job_cgroup + "/cgroup.procs", std::to_string(getpid()))) {
+            std::cerr << "pin: cannot join cgroup " << job.job_cgroup << "\n";
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "utils.h"
+// cpu_set_t, sched_setaffinity
+#include <sched.h>
+#include <tuple>
+
+// 管道各阶段的 CPU 绑定与 cgroup 放置
+//
+// pin [-a] [-c CPUS[:CPUS...]] [-g CGROUP] [-C PERCENT] [-m MEMORY] [--] pipeline
+//   -a          自动绑定，相邻阶段放在共享 L2/L3 缓存的核上
+//   -c          依次给每个阶段指定 CPU 列表（如 0-1:2:3），不够时循环使用
+//   -g          把整个作业放进 cgroup v2 的 CGROUP/job-<pid>-<n> 子树，CGROUP 相对 shell
+//               所在的 cgroup（以 / 开头时相对挂载点），作业结束后删除新建的各级目录
+//   -C / -m     该子树的 cpu.max（百分比）和 memory.max
+// 也可以在单个阶段前加 @CPUS，如 `@0 producer | @1 consumer`
+
+extern int current_stage; // 子进程所属的管道阶段
+
+bool parse_pin(std::string &cmd);
+bool parse_stage_pins(std::vector<std::string> &pipe_args);
+bool begin_job(int stage_num);
+void end_job();
+void apply_placement(int stage);
+bool parse_cpu_list(const std::string &list, cpu_set_t &set);
+std::vector<int> cache_ordered_cpus();
@@ -233,6 +233,8 @@ int exec_outer(std::vector<std::string> &args, int fd[]) {
         // 这里只有子进程才会进入
         // execvp 会完全更换子进程接下来的代码，所以正常情况下 execvp 之后这里的代码就没意义了
         // 如果 execvp 之后的代码被运行了，那就是 execvp 出问题了
+        // 按 pin 的设置绑定 CPU、加入 cgroup
+        apply_placement(current_stage);
         // 注意重定向位置
         dup2(fd[READ_END], STDIN_FILENO);
         dup2(fd[WRITE_END], STDOUT_FILENO);
@@ -243,11 +245,14 @@ int exec_outer(std::vector<std::string> &args, int fd[]) {
     }
 
     // 这里只有父进程（原进程）才会进入
-    int ret = wait(NULL);
+    int status = 0;
+    int ret = Wait(pid, &status); // 只回收自己创建的子进程
     if (ret < 0) {
         std::cout << "wait failed";
+        return 0;
     }
-    return 0;
+    // 返回命令的退出码，管道中的子进程会用它退出，交给 shell 记录管道的退出码
+    return exit_code(status);
 }
 
 int *redir_process(std::vector<std::string> &args) {
@@ -284,8 +289,8 @@ int *redir_process(std::vector<std::string> &args) {
 }
 
 // 执行单条命令，在子进程下 execute 时 terminate 为 true，运行完后终止进程
-// 父进程下 terminate 为 false 
-void execute(std::vector<std::string> &args, std::vector<std::string> &all_history, bool terminate) {
+// 父进程下 terminate 为 false，返回命令的退出码
+int execute(std::vector<std::string> &args, std::vector<std::string> &all_history, bool terminate) {
     replace_path(args);
     int res = exec_builtin(args, all_history);
     if (res == -1) {
@@ -295,6 +300,7 @@ void execute(std::vector<std::string> &args, std::vector<std::string> &all_histo
     if (terminate) {
         exit(res);
     }
+    return res;
 }
 
 void sigint_handler(int) {
@@ -317,12 +323,45 @@ std::vector<std::string> read_history() {
     return all_history;
 }
 
+// 等待管道的所有阶段结束，把最后一个阶段的退出码记到 last_status
+static void wait_pipeline(pid_t last_pid) {
+    int status = 0;
+    pid_t pid;
+    while ((pid = Wait(-1, &status)) > 0) {
+        if (pid == last_pid) {
+            last_status = exit_code(status);
+        }
+    }
+}
+
 void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
+    last_status = 1; // 命令没能运行（如 pin 的参数有误）时视为失败
+
+    // bench 需要整条管道，在拆分之前处理
+    if (is_bench(cmd)) {
+        exec_bench(cmd, all_history);
+        return;
+    }
+
+    // 处理 pin 前缀，cmd 本身还要留给 history，所以在副本上处理
+    std::string pipeline = cmd;
+    if (!parse_pin(pipeline)) {
+        end_job();
+        return;
+    }
+
     // 处理管道
-    std::vector<std::string> pipe_args = split(cmd, "|");
+    std::vector<std::string> pipe_args = split(pipeline, "|");
 
     // 没有可处理的命令
     if (pipe_args.empty()) {
+        end_job();
+        return;
+    }
+
+    // 处理各阶段前的 @CPUS，并准备 CPU 绑定和 cgroup
+    if (!parse_stage_pins(pipe_args) || !begin_job(pipe_args.size())) {
+        end_job();
         return;
     }
 
@@ -330,7 +369,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
     if (pipe_num == 1) { // 没有管道
         // 按空格分割命令为单词
         std::vector<std::string> args = parse_cmd(pipe_args[0]);
-        execute(args, all_history, false);
+        last_status = execute(args, all_history, false);
     }
 
     else if (pipe_num == 2) { // 两个进程之间通信
@@ -340,6 +379,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
         pid_t pid = Fork(); // 创建第一个子进程
 
         if (pid == 0) { // 子进程
+            current_stage = 0;
             close(fd[READ_END]);
             dup2(fd[WRITE_END], STDOUT_FILENO); // 将标准输出重定向到管道的写端口
             close(fd[WRITE_END]);
@@ -353,6 +393,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
             pid = Fork(); // 创建第二个子进程
 
             if (pid == 0) { // 子进程
+                current_stage = 1;
                 close(fd[WRITE_END]);
                 dup2(fd[READ_END], STDIN_FILENO); // 将标准输入重定向到管道的读端口
                 close(fd[READ_END]);
@@ -366,13 +407,14 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
                 close(fd[WRITE_END]);
                 close(fd[READ_END]);
 
-                while (wait(NULL) > 0); // 等待所有子进程结束
+                wait_pipeline(pid); // 等待所有子进程结束
             }
         }
     }
 
     else { // 多个进程
         int last_read_end = STDIN_FILENO; // 上个管道的读端，应该连到下个进程的写端
+        pid_t last_pid = -1;
         for (int i = 0; i < pipe_num; ++i) {
             int fd[2]; // 注意需要创建 n - 1 个不同管道
             if (i < pipe_num - 1) { // 最后一条不创建管道（不需要再把输出传给别人）
@@ -382,6 +424,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
             pid_t pid = Fork();
 
             if (pid == 0) { // 子进程
+                current_stage = i;
                 if (i > 0) {
                     dup2(last_read_end, STDIN_FILENO); // 后面的不从标准输入拿，找 last_read_end
                 }
@@ -395,6 +438,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
             }
 
             else { // 父进程
+                last_pid = pid;
                 close(fd[WRITE_END]); // 父进程用不到 write_end
                 if (i > 0) {
                     close(last_read_end); // 关闭当前命令用完的 last_read_end
@@ -402,6 +446,7 @@ void exec_pipe(std::string &cmd, std::vector<std::string> &all_history) {
                 last_read_end = fd[READ_END]; // 更新 last_read_end
             }
         }
-        while (wait(NULL) > 0); // 等待所有子进程结束
+        wait_pipeline(last_pid); // 等待所有子进程结束
     }
+    end_job();
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "utils.h"
+#include "placement.h"
+#include "bench.h"
 
 #define WRITE_END 1 // pipe 写端口
 #define READ_END 0  // pipe 读端口
@@ -7,7 +9,7 @@
 
 int exec_builtin(std::vector<std::string> &args, std::vector<std::string> &all_history);
 int exec_outer(std::vector<std::string> &args, int fd[]);
-void execute(std::vector<std::string> &args, std::vector<std::string> &all_history, bool terminate);
+int execute(std::vector<std::string> &args, std::vector<std::string> &all_history, bool terminate);
 void exec_pipe(std::string &, std::vector<std::string> &);
 int *redir_process(std::vector<std::string> &args);
 void sigint_handler(int);
@@ -1,21 +1,21 @@
 #include "utils.h"
 
 // trim from start (in place)
-inline void ltrim(std::string &s) {
+void ltrim(std::string &s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) {
         return !std::isspace(ch);
         }));
 }
 
 // trim from end (in place)
-inline void rtrim(std::string &s) {
+void rtrim(std::string &s) {
     s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) {
         return !std::isspace(ch);
         }).base(), s.end());
 }
 
 // trim from both ends (in place)
-inline void trim(std::string &s) {
+void trim(std::string &s) {
     ltrim(s);
     rtrim(s);
 }
@@ -109,6 +109,36 @@ void Pipe(int fd[]) {
     }
 }
 
+struct rusage child_usage;
+int last_status = 0;
+
+// 回收子进程（pid 为 -1 时任意一个），并把它（及其已回收的后代）的 CPU 时间累加到 child_usage。
+// 被信号打断时继续等待，否则没回收的子进程会被之后的 Wait 错当成别的命令回收
+pid_t Wait(pid_t pid, int *status) {
+    struct rusage usage;
+    int wstatus = 0;
+    pid_t ret;
+    do {
+        ret = wait4(pid, &wstatus, 0, &usage);
+    } while (ret < 0 && errno == EINTR);
+    if (ret > 0) {
+        timeradd(&child_usage.ru_utime, &usage.ru_utime, &child_usage.ru_utime);
+        timeradd(&child_usage.ru_stime, &usage.ru_stime, &child_usage.ru_stime);
+        if (status) {
+            *status = wstatus;
+        }
+    }
+    return ret;
+}
+
+// 把 wait 得到的状态换成 shell 习惯的退出码
+int exit_code(int status) {
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return WEXITSTATUS(status);
+}
+
 void replace_path(std::vector<std::string> &args) { // 把路径中 ~ 换成家目录
     int len = args.size();
     for (int i = 0; i != len; ++i) {
@@ -25,6 +25,9 @@
 #include <cstring>
 // open
 #include <fcntl.h>
+// wait4, timeradd
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <unordered_map>
 
 const int UP = 65;
@@ -34,12 +37,16 @@ const int LEFT = 68;
 
 pid_t Fork();
 void Pipe(int fd[]);
+pid_t Wait(pid_t pid = -1, int *status = NULL);
+int exit_code(int status);
+extern struct rusage child_usage; // Wait 回收的子进程累计的资源使用
+extern int last_status;           // 上一条管道最后一个阶段的退出码，被信号杀死时为 128 + 信号
 typedef void handler_t(int);
 std::vector<std::string> split(std::string s, const std::string &delimiter);
 int lg(int);
-inline void ltrim(std::string &s);
-inline void rtrim(std::string &s);
-inline void trim(std::string &s);
+void ltrim(std::string &s);
+void rtrim(std::string &s);
+void trim(std::string &s);
 void replace_path(std::vector<std::string> &args);
 inline std::string get_user_name();
 void print_prompt();
@@ -0,0 +1,12 @@
+// 最紧凑的系统调用循环：每次迭代 1 个系统调用
+#include <sys/syscall.h>
+
+#include "tracee.h"
+
+int main(int argc, char **argv) {
+    long n = bench_iterations(argc, argv);
+    bench_gate();
+    for (long i = 0; i < n; ++i)
+        syscall(SYS_getppid); // 绕过 glibc 可能的缓存
+    return 0;
+}
@@ -0,0 +1,16 @@
+// 频繁打开关闭文件：每次迭代 openat + close 共 2 个系统调用
+#include <fcntl.h>
+
+#include "tracee.h"
+
+int main(int argc, char **argv) {
+    long n = bench_iterations(argc, argv);
+    bench_gate();
+    for (long i = 0; i < n; ++i) {
+        int fd = open("/dev/null", O_RDONLY);
+        if (fd == -1)
+            return EXIT_FAILURE;
+        close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+// 管道上的小块读写：每次迭代 write + read 共 2 个系统调用
+#include "tracee.h"
+
+int main(int argc, char **argv) {
+    long n = bench_iterations(argc, argv);
+    int fd[2];
+    if (pipe(fd) == -1)
+        return EXIT_FAILURE;
+    bench_gate();
+
+    char buf[64] = { 0 };
+    for (long i = 0; i < n; ++i) {
+        if (write(fd[1], buf, sizeof(buf)) != sizeof(buf))
+            return EXIT_FAILURE;
+        if (read(fd[0], buf, sizeof(buf)) != sizeof(buf))
+            return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+// 测量 strace 各种模式相对不跟踪时的开销，结果以 JSON 输出到标准输出
+// 用法：run_bench STRACE BINDIR ITERATIONS REPEAT
+#define _POSIX_C_SOURCE 200112L
+
+/* C standard library */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* POSIX */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* C++ */
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tracee.h"
+
+#define FATAL(...) \
+    do { \
+        fprintf(stderr, "run_bench: " __VA_ARGS__); \
+        fputc('\n', stderr); \
+        exit(EXIT_FAILURE); \
+    } while (0)
+
+struct workload {
+    const char *name;
+    long syscalls_per_iteration; // 每次迭代的系统调用数，thread_storm 为线程数
+};
+
+struct mode {
+    const char *name;
+    std::vector<std::string> args; // 传给 strace 的参数
+    bool traced;
+    bool attach; // 用 -p 附加到已启动的进程
+};
+
+static const workload workloads[] = {
+    { "getppid_loop", 1 },
+    { "pipe_rw", 2 },
+    { "open_close", 2 },
+    { "thread_storm", BENCH_THREADS },
+};
+
+static const std::vector<mode> modes = {
+    { "untraced", {}, false, false },
+    { "trace", {}, true, false },
+    { "timed", { "-T" }, true, false },
+    { "slow_filter", { "--slower-than=1000000" }, true, false },
+    { "attach", { "-p" }, true, true },
+    // 注入规则针对 getpid(39)，这些程序的循环里不会调用，衡量的是注入机制本身的开销
+    { "inject", { "--inject=39:delay=0" }, true, false },
+    { "seccomp_inject", { "--seccomp-bpf", "--inject=39:delay=0" }, true, false },
+};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 启动子进程，丢弃其输出；stdin_fd 不为 -1 时作为子进程的标准输入
+static pid_t spawn(const std::vector<std::string> &args, int stdin_fd, bool gate) {
+    pid_t pid = fork();
+    if (pid == -1)
+        FATAL("fork: %s", strerror(errno));
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        if (stdin_fd != -1)
+            dup2(stdin_fd, STDIN_FILENO);
+        if (gate)
+            setenv("BENCH_GATE", "1", 1);
+
+        std::vector<char *> argv;
+        for (const auto &arg : args)
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    return pid;
+}
+
+static void reap(pid_t pid, const char *what) {
+    int status;
+    if (waitpid(pid, &status, 0) == -1)
+        FATAL("waitpid: %s", strerror(errno));
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        FATAL("%s failed (status 0x%x)", what, status);
+}
+
+static bool is_traced(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+        return false;
+    char line[256];
+    int tracer = 0;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "TracerPid: %d", &tracer) == 1)
+            break;
+    fclose(f);
+    return tracer != 0;
+}
+
+// -p 模式：被跟踪程序先阻塞在标准输入上，等 strace 附加完成后再放行并计时
+static double run_attached(const char *strace, const std::vector<std::string> &prog, const mode &m) {
+    int gate[2];
+    if (pipe(gate) == -1)
+        FATAL("pipe: %s", strerror(errno));
+    pid_t tracee = spawn(prog, gate[0], true);
+    close(gate[0]);
+
+    std::vector<std::string> args = { strace };
+    args.insert(args.end(), m.args.begin(), m.args.end());
+    args.push_back(std::to_string(tracee));
+    pid_t tracer = spawn(args, -1, false);
+
+    double deadline = now() + 5;
+    while (!is_traced(tracee)) {
+        if (now() > deadline)
+            FATAL("strace did not attach to %d", tracee);
+        usleep(1000);
+    }
+
+    double start = now();
+    if (write(gate[1], "x", 1) != 1)
+        FATAL("write: %s", strerror(errno));
+    close(gate[1]);
+    reap(tracee, prog[0].c_str());
+    double elapsed = now() - start;
+    reap(tracer, strace);
+    return elapsed;
+}
+
+static double run_once(const char *strace, const std::vector<std::string> &prog, const mode &m) {
+    if (m.attach)
+        return run_attached(strace, prog, m);
+
+    std::vector<std::string> args;
+    if (m.traced) {
+        args.push_back(strace);
+        args.insert(args.end(), m.args.begin(), m.args.end());
+    }
+    args.insert(args.end(), prog.begin(), prog.end());
+
+    double start = now();
+    reap(spawn(args, -1, false), args[0].c_str());
+    return now() - start;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5)
+        FATAL("usage: %s STRACE BINDIR ITERATIONS REPEAT", argv[0]);
+    const char *strace = argv[1];
+    std::string bindir = argv[2];
+    long iterations = strtol(argv[3], nullptr, 10);
+    int repeat = atoi(argv[4]);
+    if (iterations <= 0 || repeat <= 0)
+        FATAL("ITERATIONS and REPEAT must be positive");
+
+    printf("{\n  \"iterations\": %ld,\n  \"repeat\": %d,\n  \"workloads\": [\n", iterations, repeat);
+    size_t nworkloads = sizeof(workloads) / sizeof(workloads[0]);
+    for (size_t w = 0; w < nworkloads; ++w) {
+        std::vector<std::string> prog = { bindir + "/" + workloads[w].name, std::to_string(iterations) };
+        long syscalls = iterations * workloads[w].syscalls_per_iteration;
+        printf("    {\n      \"name\": \"%s\",\n      \"syscalls\": %ld,\n      \"modes\": [\n",
+            workloads[w].name, syscalls);
+
+        double baseline = 0;
+        for (size_t i = 0; i < modes.size(); ++i) {
+            // 取中位数，减少偶然抖动的影响
+            std::vector<double> samples;
+            for (int r = 0; r < repeat; ++r)
+                samples.push_back(run_once(strace, prog, modes[i]));
+            std::sort(samples.begin(), samples.end());
+            double median = samples[samples.size() / 2];
+            if (i == 0)
+                baseline = median;
+
+            printf("        { \"mode\": \"%s\", \"seconds\": %.6f, \"syscalls_per_sec\": %.0f, \"slowdown\": %.2f }%s\n",
+                modes[i].name, median, syscalls / median, median / baseline,
+                i + 1 < modes.size() ? "," : "");
+            fflush(stdout);
+        }
+        printf("      ]\n    }%s\n", w + 1 < nworkloads ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+// 多线程系统调用风暴：BENCH_THREADS 个线程各做 ITERATIONS 次 getppid
+#include <sys/syscall.h>
+
+#include <thread>
+#include <vector>
+
+#include "tracee.h"
+
+int main(int argc, char **argv) {
+    long n = bench_iterations(argc, argv);
+    bench_gate();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < BENCH_THREADS; ++i) {
+        threads.emplace_back([n] {
+            for (long j = 0; j < n; ++j)
+                syscall(SYS_getppid);
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/* C standard library */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* POSIX */
+#include <unistd.h>
+
+// thread_storm 的线程数，run_bench 据此计算系统调用总数
+#define BENCH_THREADS 4
+
+// 基准测试用的被跟踪程序共用的部分
+// 用法：PROG ITERATIONS，设置了 BENCH_GATE 时先从标准输入读一个字节再开始，
+// 让 run_bench 在 strace -p 附加完成后再放行
+
+static inline long bench_iterations(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s ITERATIONS\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    long n = strtol(argv[1], nullptr, 10);
+    if (n <= 0) {
+        fprintf(stderr, "%s: invalid iteration count '%s'\n", argv[0], argv[1]);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+static inline void bench_gate() {
+    if (getenv("BENCH_GATE") == nullptr)
+        return;
+    char c;
+    if (read(STDIN_FILENO, &c, 1) != 1)
+        exit(EXIT_FAILURE);
+}
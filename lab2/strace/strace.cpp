@@ -2,62 +2,569 @@
 
 /* C standard library */
 #include <errno.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* POSIX */
+#include <dirent.h>
+#include <getopt.h>
 #include <unistd.h>
 #include <sys/user.h>
 #include <sys/wait.h>
 
 /* Linux */
 #include <syscall.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
 #include <sys/ptrace.h>
 
+/* C++ */
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#define FATAL(...) \
+    do { \
+        fprintf(stderr, "strace: " __VA_ARGS__); \
+        fputc('\n', stderr); \
+        exit(EXIT_FAILURE); \
+    } while (0)
+
+// 每个被跟踪线程的状态
+struct tracee {
+    bool in_syscall = false;      // 是否处于 syscall-enter-stop 与 syscall-exit-stop 之间
+    bool delayed = false;         // 停在入口处等待注入的延迟结束
+    int inject_error = 0;         // 出口处要写入的错误码，0 表示不注入
+    std::map<long, long> counts;  // 该线程进入各个被注入系统调用的次数
+    struct user_regs_struct regs; // syscall-enter-stop 时的寄存器
+    struct timespec start;        // 进入系统调用的时间
+};
+
+// --inject 指定的注入规则，同一个系统调用的延迟和错误可以同时存在
+struct injection {
+    long delay_usec = -1; // -1 表示不注入延迟
+    long every = 1;       // 每 N 次调用注入一次延迟
+    int error = 0;        // 0 表示不注入错误
+    long when = 1;        // 从第 K 次调用开始注入错误
+    bool onwards = true;  // when=K+ 为 true，when=K 只注入第 K 次
+};
+
+static std::map<pid_t, tracee> tracees;
+static std::set<pid_t> leaders; // -p 指定的或由我们启动的进程，退出时打印退出状态
+static std::map<long, injection> injections;    // 系统调用号 -> 注入规则
+static std::multimap<long long, pid_t> wakeups; // 延迟结束时间（纳秒）-> 线程
+
+static bool show_time = false;   // -T
+static long slower_than = -1;    // --slower-than=USEC，-1 表示不过滤
+static bool seized = false;      // -p 模式下用 PTRACE_SEIZE 附加
+static bool seccomp_bpf = false; // --seccomp-bpf，只在被注入的系统调用处停下
+// 处理完一次停止后恢复运行的方式，seccomp 模式下不需要停在每个系统调用上
+static enum __ptrace_request resume_request = PTRACE_SYSCALL;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int) {
+    interrupted = 1;
+}
+
+static long elapsed_usec(const struct timespec &start, const struct timespec &end) {
+    return (end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+static long long now_nsec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 打印一次系统调用，ret 为 nullptr 表示调用没有返回（如 exit_group）
+static void print_syscall(pid_t tid, const tracee &t, const long *ret) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long usec = elapsed_usec(t.start, now);
+    if (slower_than >= 0 && (ret == nullptr || usec < slower_than))
+        return;
+
+    const struct user_regs_struct &regs = t.regs;
+    if (tracees.size() > 1)
+        fprintf(stderr, "[pid %5d] ", tid);
+    fprintf(stderr, "%ld(%ld, %ld, %ld, %ld, %ld, %ld)",
+        (long) regs.orig_rax,
+        (long) regs.rdi, (long) regs.rsi, (long) regs.rdx,
+        (long) regs.r10, (long) regs.r8, (long) regs.r9);
+    if (ret)
+        fprintf(stderr, " = %ld", *ret);
+    else
+        fprintf(stderr, " = ?");
+    if (t.inject_error)
+        fprintf(stderr, " (INJECTED)");
+    if (show_time && ret)
+        fprintf(stderr, " <%ld.%06ld>", usec / 1000000, usec % 1000000);
+    fputc('\n', stderr);
+}
+
+static void parse_pids(const char *arg, std::vector<pid_t> &pids) {
+    const char *p = arg;
+    while (*p) {
+        char *end;
+        errno = 0;
+        long pid = strtol(p, &end, 10);
+        if (errno || end == p || pid <= 0 || (*end && *end != ','))
+            FATAL("invalid process id: '%s'", arg);
+        pids.push_back((pid_t) pid);
+        p = *end ? end + 1 : end;
+    }
+}
+
+static long parse_number(const std::string &s, const char *arg) {
+    char *end;
+    errno = 0;
+    long n = strtol(s.c_str(), &end, 10);
+    if (errno || s.empty() || *end || n < 0)
+        FATAL("invalid --inject argument: '%s'", arg);
+    return n;
+}
+
+// 错误码可以写成数字或 ENOENT 这样的名字
+static int parse_errno(const std::string &s, const char *arg) {
+    for (int e = 1; e < 4096; ++e) {
+        const char *name = strerrorname_np(e);
+        if (name && s == name)
+            return e;
+    }
+    long e = parse_number(s, arg);
+    if (e == 0 || e >= 4096)
+        FATAL("invalid --inject argument: '%s'", arg);
+    return (int) e;
+}
+
+// SYSCALL:delay=USEC[:every=N] 或 SYSCALL:error=ERRNO[:when=K[+]]，SYSCALL 为系统调用号
+static void parse_inject(const char *arg) {
+    std::vector<std::string> fields;
+    std::string s = arg;
+    size_t pos;
+    while ((pos = s.find(':')) != std::string::npos) {
+        fields.push_back(s.substr(0, pos));
+        s = s.substr(pos + 1);
+    }
+    fields.push_back(s);
+    if (fields.size() < 2)
+        FATAL("invalid --inject argument: '%s'", arg);
+
+    injection &inj = injections[parse_number(fields[0], arg)];
+    for (size_t i = 1; i < fields.size(); ++i) {
+        const std::string &field = fields[i];
+        size_t eq = field.find('=');
+        if (eq == std::string::npos)
+            FATAL("invalid --inject argument: '%s'", arg);
+        std::string key = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+
+        if (key == "delay") {
+            inj.delay_usec = parse_number(value, arg);
+        } else if (key == "every") {
+            inj.every = parse_number(value, arg);
+            if (inj.every == 0)
+                FATAL("invalid --inject argument: '%s'", arg);
+        } else if (key == "error") {
+            inj.error = parse_errno(value, arg);
+        } else if (key == "when") {
+            inj.onwards = !value.empty() && value.back() == '+';
+            if (inj.onwards)
+                value.pop_back();
+            inj.when = parse_number(value, arg);
+            if (inj.when == 0)
+                FATAL("invalid --inject argument: '%s'", arg);
+        } else {
+            FATAL("invalid --inject argument: '%s'", arg);
+        }
+    }
+}
+
+// 在被启动的程序中安装 seccomp 过滤器，只有被注入的系统调用会让跟踪者停下
+static void install_seccomp_filter() {
+    std::vector<struct sock_filter> filter = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+    };
+    for (const auto &item : injections) {
+        filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (__u32) item.first, 0, 1));
+        filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRACE));
+    }
+    filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+
+    struct sock_fprog prog;
+    prog.len = (unsigned short) filter.size();
+    prog.filter = filter.data();
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1)
+        FATAL("PR_SET_NO_NEW_PRIVS: %s", strerror(errno));
+    if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == -1)
+        FATAL("PR_SET_SECCOMP: %s", strerror(errno));
+}
+
+// 附加到 /proc/PID/task 下的所有线程。附加期间可能有新线程产生，
+// 已附加线程创建的新线程会被 PTRACE_O_TRACECLONE 自动跟踪，所以重复扫描直到没有新线程
+static void attach_process(pid_t pid, long options) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+    bool found_new = true;
+    while (found_new) {
+        found_new = false;
+        DIR *dir = opendir(path);
+        if (dir == nullptr)
+            FATAL("cannot attach to process %d: %s", pid, strerror(errno));
+
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            pid_t tid = (pid_t) strtol(entry->d_name, nullptr, 10);
+            if (tid <= 0 || tracees.count(tid))
+                continue;
+            if (ptrace(PTRACE_SEIZE, tid, 0, options) == -1) {
+                if (errno == ESRCH) // 线程已经退出
+                    continue;
+                FATAL("PTRACE_SEIZE %d: %s", tid, strerror(errno));
+            }
+            if (ptrace(PTRACE_INTERRUPT, tid, 0, 0) == -1 && errno != ESRCH)
+                FATAL("PTRACE_INTERRUPT %d: %s", tid, strerror(errno));
+            tracees[tid];
+            found_new = true;
+        }
+        closedir(dir);
+    }
+    leaders.insert(pid);
+    fprintf(stderr, "strace: Process %d attached\n", pid);
+}
+
+// 收到 SIGINT 后让所有线程停下并脱离，被跟踪的进程继续运行
+static void detach_all() {
+    for (auto &item : tracees) {
+        pid_t tid = item.first;
+        tracee &t = item.second;
+        // 等待延迟的线程已经处于停止状态，恢复可能被改成 -1 的 orig_rax 后直接脱离，
+        // 否则脱离后真正的系统调用会被跳过并返回 -ENOSYS
+        if (t.delayed) {
+            if (t.inject_error)
+                ptrace(PTRACE_SETREGS, tid, 0, &t.regs);
+            ptrace(PTRACE_DETACH, tid, 0, 0);
+            continue;
+        }
+        if (ptrace(PTRACE_INTERRUPT, tid, 0, 0) == -1)
+            continue;
+
+        int status;
+        while (waitpid(tid, &status, __WALL) == tid) {
+            if (WIFEXITED(status) || WIFSIGNALED(status))
+                break;
+            if (!WIFSTOPPED(status))
+                continue;
+            // 信号投递停止时把信号转交回去，避免信号丢失
+            int sig = WSTOPSIG(status);
+            // 先报告的是被注入调用的 syscall-exit-stop 时，照常写入错误码
+            if (sig == (SIGTRAP | 0x80) && t.in_syscall && t.inject_error) {
+                struct user_regs_struct regs;
+                if (ptrace(PTRACE_GETREGS, tid, 0, &regs) == 0) {
+                    regs.rax = -t.inject_error;
+                    ptrace(PTRACE_SETREGS, tid, 0, &regs);
+                }
+            }
+            if (sig == (SIGTRAP | 0x80) || (status >> 16) != 0)
+                sig = 0;
+            ptrace(PTRACE_DETACH, tid, 0, sig);
+            break;
+        }
+    }
+    for (pid_t pid : leaders)
+        fprintf(stderr, "strace: Process %d detached\n", pid);
+    tracees.clear();
+}
+
+// 系统调用入口：记录参数，按规则注入错误或延迟。返回 false 表示线程要等延迟结束后再恢复
+static bool on_syscall_entry(pid_t tid, tracee &t) {
+    if (ptrace(PTRACE_GETREGS, tid, 0, &t.regs) == -1) {
+        if (errno == ESRCH) // 线程被杀死，等 waitpid 报告退出
+            return false;
+        FATAL("PTRACE_GETREGS: %s", strerror(errno));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t.start);
+    t.in_syscall = true;
+    t.inject_error = 0;
+
+    auto it = injections.find((long) t.regs.orig_rax);
+    if (it == injections.end())
+        return true;
+    // every=N 和 when=K 按线程分别计数，互不相关的线程和进程不会相互影响
+    const injection &inj = it->second;
+    long count = ++t.counts[it->first];
+
+    // 把系统调用号改为无效值让内核跳过这次调用，出口处再写入错误码
+    if (inj.error && (count == inj.when || (inj.onwards && count > inj.when))) {
+        struct user_regs_struct regs = t.regs;
+        regs.orig_rax = -1;
+        if (ptrace(PTRACE_SETREGS, tid, 0, &regs) == -1 && errno != ESRCH)
+            FATAL("PTRACE_SETREGS: %s", strerror(errno));
+        t.inject_error = inj.error;
+    }
+
+    // 延迟不能在这里 sleep，否则会阻塞其他线程；让线程保持停止，到时间再恢复
+    if (inj.delay_usec >= 0 && count % inj.every == 0) {
+        t.delayed = true;
+        wakeups.emplace(now_nsec() + inj.delay_usec * 1000LL, tid);
+        return false;
+    }
+    return true;
+}
+
+static void on_syscall_exit(pid_t tid, tracee &t) {
+    struct user_regs_struct regs;
+    if (ptrace(PTRACE_GETREGS, tid, 0, &regs) == -1) {
+        if (errno == ESRCH)
+            return;
+        FATAL("PTRACE_GETREGS: %s", strerror(errno));
+    }
+    if (t.inject_error) {
+        regs.rax = -t.inject_error;
+        if (ptrace(PTRACE_SETREGS, tid, 0, &regs) == -1 && errno != ESRCH)
+            FATAL("PTRACE_SETREGS: %s", strerror(errno));
+    }
+    long ret = (long) regs.rax;
+    print_syscall(tid, t, &ret);
+    t.in_syscall = false;
+    t.inject_error = 0;
+}
+
+// 恢复延迟已经结束的线程，它们停在系统调用入口，需要 PTRACE_SYSCALL 才能看到出口
+static void resume_due() {
+    long long now = now_nsec();
+    while (!wakeups.empty() && wakeups.begin()->first <= now) {
+        pid_t tid = wakeups.begin()->second;
+        wakeups.erase(wakeups.begin());
+        auto it = tracees.find(tid);
+        if (it == tracees.end())
+            continue;
+        it->second.delayed = false;
+        if (ptrace(PTRACE_SYSCALL, tid, 0, 0) == -1 && errno != ESRCH)
+            FATAL("PTRACE_SYSCALL: %s", strerror(errno));
+    }
+}
+
+// 有线程在等待延迟时不能阻塞在 waitpid 上：SIGCHLD 已被屏蔽，用 sigtimedwait 等到
+// 下一个子进程事件或最早的延迟结束
+static void wait_for_event() {
+    long long timeout = wakeups.begin()->first - now_nsec();
+    if (timeout <= 0)
+        return;
+    struct timespec ts;
+    ts.tv_sec = timeout / 1000000000LL;
+    ts.tv_nsec = timeout % 1000000000LL;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigtimedwait(&set, nullptr, &ts);
+}
+
 int main(int argc, char **argv) {
-    if (argc <= 1)
+    static const struct option long_options[] = {
+        { "slower-than", required_argument, nullptr, 's' },
+        { "inject", required_argument, nullptr, 'i' },
+        { "seccomp-bpf", no_argument, nullptr, 'b' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<pid_t> pids;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "+p:T", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'p':
+            parse_pids(optarg, pids);
+            break;
+        case 'T':
+            show_time = true;
+            break;
+        case 's': {
+            char *end;
+            errno = 0;
+            slower_than = strtol(optarg, &end, 10);
+            if (errno || end == optarg || *end || slower_than < 0)
+                FATAL("invalid --slower-than argument: '%s'", optarg);
+            break;
+        }
+        case 'i':
+            parse_inject(optarg);
+            break;
+        case 'b':
+            seccomp_bpf = true;
+            break;
+        default:
+            FATAL("usage: %s [-T] [--slower-than=USEC] [--inject=SPEC]... [--seccomp-bpf] "
+                "{-p PID[,PID...] | PROG [ARGS...]}", argv[0]);
+        }
+    }
+
+    if (pids.empty() && optind >= argc)
         FATAL("too few arguments: %d", argc);
+    if (!pids.empty() && optind < argc)
+        FATAL("-p and a command are mutually exclusive");
+    if (seccomp_bpf && !pids.empty())
+        FATAL("--seccomp-bpf cannot be used with -p");
+    if (seccomp_bpf && injections.empty())
+        FATAL("--seccomp-bpf requires at least one --inject");
+
+    long options = PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC;
+    if (seccomp_bpf) {
+        // 子进程会继承过滤器，没有跟踪者时 SECCOMP_RET_TRACE 会让调用失败，所以也要跟踪子进程
+        options |= PTRACE_O_TRACESECCOMP | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK;
+        resume_request = PTRACE_CONT;
+    }
+
+    // 屏蔽 SIGCHLD，等待注入的延迟时用 sigtimedwait 接收，不会错过子进程事件
+    sigset_t chld_set;
+    sigemptyset(&chld_set);
+    sigaddset(&chld_set, SIGCHLD);
+
+    if (!pids.empty()) {
+        seized = true;
+        // 不带 SA_RESTART，让阻塞中的 waitpid 返回 EINTR
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_interrupt;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        sigprocmask(SIG_BLOCK, &chld_set, nullptr);
+
+        for (pid_t pid : pids)
+            attach_process(pid, options);
+    } else {
+        pid_t pid = fork();
+        switch (pid) {
+        case -1:
+            FATAL("fork: %s", strerror(errno));
+        case 0:
+            ptrace(PTRACE_TRACEME, 0, 0, 0);
+            if (seccomp_bpf)
+                install_seccomp_filter();
+            execvp(argv[optind], argv + optind);
+            FATAL("cannot run '%s': %s", argv[optind], strerror(errno));
+        }
+
+        // Ctrl + C 交给被跟踪进程处理，我们只负责报告它的结局
+        signal(SIGINT, SIG_IGN);
+        sigprocmask(SIG_BLOCK, &chld_set, nullptr);
+
+        int status;
+        if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status))
+            FATAL("cannot trace '%s'", argv[optind]);
+        if (ptrace(PTRACE_SETOPTIONS, pid, 0, options | PTRACE_O_EXITKILL) == -1)
+            FATAL("PTRACE_SETOPTIONS: %s", strerror(errno));
+        tracees[pid];
+        leaders.insert(pid);
+        if (ptrace(resume_request, pid, 0, 0) == -1)
+            FATAL("%s: %s", seccomp_bpf ? "PTRACE_CONT" : "PTRACE_SYSCALL", strerror(errno));
+    }
+
+    int exit_code = 0;
+    while (!tracees.empty()) {
+        resume_due();
+        if (interrupted) {
+            detach_all();
+            break;
+        }
+
+        int status;
+        pid_t tid = waitpid(-1, &status, __WALL | (wakeups.empty() ? 0 : WNOHANG));
+        if (tid == 0) {
+            wait_for_event();
+            continue;
+        }
+        if (tid == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ECHILD)
+                break;
+            FATAL("waitpid: %s", strerror(errno));
+        }
 
-    pid_t pid = fork();
-    switch (pid) {
-    case -1:
-        exit(1);
-    case 0:
-        ptrace(PTRACE_TRACEME, 0, 0, 0);
-        execvp(argv[1], argv + 1);
-        exit(1);
-    }
-
-    waitpid(pid, 0, 0);
-    ptrace(PTRACE_SETOPTIONS, pid, 0, PTRACE_O_EXITKILL);
-
-    for (;;) {
-        if (ptrace(PTRACE_SYSCALL, pid, 0, 0) == -1)
-            exit(1);
-        if (waitpid(pid, 0, 0) == -1)
-            exit(1);
-
-        // 获取系统调用参数
-        struct user_regs_struct regs;
-        if (ptrace(PTRACE_GETREGS, pid, 0, &regs) == -1)
-            exit(1);
-        long syscall = regs.orig_rax;
-        fprintf(stderr, "%ld(%ld, %ld, %ld, %ld, %ld, %ld)\n",
-            syscall,
-            (long) regs.rdi, (long) regs.rsi, (long) regs.rdx,
-            (long) regs.r10, (long) regs.r8, (long) regs.r9);
-
-        if (ptrace(PTRACE_SYSCALL, pid, 0, 0) == -1)
-            exit(1);
-        if (waitpid(pid, 0, 0) == -1)
-            exit(1);
-
-        if (ptrace(PTRACE_GETREGS, pid, 0, &regs) == -1) {
-            if (errno == ESRCH)
-                exit(regs.rdi);
-            exit(1);
+        // 被跟踪线程退出，从 waitpid 的状态中解出真实的退出码
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            auto it = tracees.find(tid);
+            if (it != tracees.end()) {
+                if (it->second.in_syscall)
+                    print_syscall(tid, it->second, nullptr);
+                tracees.erase(it);
+            }
+            if (leaders.count(tid)) {
+                if (WIFEXITED(status)) {
+                    exit_code = WEXITSTATUS(status);
+                    fprintf(stderr, "+++ exited with %d +++\n", exit_code);
+                } else {
+                    exit_code = 128 + WTERMSIG(status);
+                    fprintf(stderr, "+++ killed by %s +++\n", strsignal(WTERMSIG(status)));
+                }
+            }
+            continue;
         }
+        if (!WIFSTOPPED(status))
+            continue;
+
+        // 自动跟踪的新线程可能在 PTRACE_EVENT_CLONE 之前就报告了停止
+        bool is_new = !tracees.count(tid);
+        tracee &t = tracees[tid];
+        int sig = WSTOPSIG(status);
+        int event = status >> 16;
+        int inject = 0;
+        enum __ptrace_request request = resume_request;
+
+        if (sig == (SIGTRAP | 0x80)) { // syscall-stop
+            if (!t.in_syscall) {
+                if (!on_syscall_entry(tid, t))
+                    continue;
+                request = PTRACE_SYSCALL;
+            } else {
+                on_syscall_exit(tid, t);
+            }
+        } else if (event == PTRACE_EVENT_SECCOMP) {
+            // seccomp 停止发生在系统调用入口，之后用 PTRACE_SYSCALL 等它的出口
+            if (!on_syscall_entry(tid, t))
+                continue;
+            request = PTRACE_SYSCALL;
+        } else if (event == PTRACE_EVENT_STOP) {
+            // PTRACE_SEIZE 模式下的组停止，用 PTRACE_LISTEN 保持停止而不丢失后续事件
+            if (sig == SIGSTOP || sig == SIGTSTP || sig == SIGTTIN || sig == SIGTTOU) {
+                ptrace(PTRACE_LISTEN, tid, 0, 0);
+                continue;
+            }
+        } else if (event == PTRACE_EVENT_EXEC) {
+            // execve 之后还会有一次 syscall-exit-stop，in_syscall 保持不变以便正确配对。
+            // 非主线程执行 execve 后会换成主线程的 id，把旧 id 的状态搬过来
+            unsigned long former;
+            if (ptrace(PTRACE_GETEVENTMSG, tid, 0, &former) == 0 && (pid_t) former != tid) {
+                auto it = tracees.find((pid_t) former);
+                if (it != tracees.end()) {
+                    t = it->second;
+                    tracees.erase(it);
+                }
+            }
+        } else if (event != 0) {
+            // PTRACE_EVENT_CLONE 等事件，无需处理
+        } else if (is_new && sig == SIGSTOP) {
+            // 非 SEIZE 模式下自动跟踪的新线程以 SIGSTOP 开始，不要转交
+        } else {
+            inject = sig; // 信号投递停止，把信号交给被跟踪线程
+        }
+
+        if (ptrace(request, tid, 0, inject) == -1 && errno != ESRCH)
+            FATAL("ptrace resume: %s", strerror(errno));
     }
+
+    // 附加模式下被跟踪进程不是我们的子进程，其退出码仅作报告
+    return seized ? 0 : exit_code;
 }